@@ -0,0 +1,20 @@
+if (TARGET xxhash)
+    return()
+endif()
+
+# NOTE: you can avoid downloading xxhash, by symlinking to a downloaded version here:
+find_path(XXHASH_DIR NAMES xxhash.h PATHS ${CMAKE_SOURCE_DIR}/symlinks/xxhash)
+if(XXHASH_DIR STREQUAL "XXHASH_DIR-NOTFOUND")
+    include(FetchContent)
+    FetchContent_Populate(xxhash
+        GIT_REPOSITORY https://github.com/Cyan4973/xxHash)
+    set(XXHASH_DIR ${xxhash_SOURCE_DIR})
+endif()
+
+# used header-only
+add_library(xxhash INTERFACE)
+target_include_directories(xxhash INTERFACE ${XXHASH_DIR})
+target_compile_definitions(xxhash INTERFACE XXH_INLINE_ALL)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(xxhash REQUIRED_VARS XXHASH_DIR)
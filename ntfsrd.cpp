@@ -2,6 +2,16 @@
 #include <map>
 #include <set>
 #include <memory>
+#include <bit>
+#include <functional>
+#ifdef WITH_OPENSSL
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <openssl/evp.h>
+#include <xxhash.h>
+#endif
 #include "util/HiresTimer.h"
 #include "util/ReadWriter.h"
 #include "util/rw/BlockDevice.h"
@@ -10,6 +20,123 @@
 #include "util/rw/OffsetReader.h"
 #include "args.h"
 
+typedef std::shared_ptr<const ByteVector> ByteVector_ptr;
+
+#ifdef WITH_OPENSSL
+// feeds queued chunks to a digest function on a separate thread
+class hashworker {
+    enum { MAXQUEUE= 16 };
+    std::function<void(const uint8_t*,size_t)> _update;
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    std::deque<ByteVector_ptr> _queue;
+    bool _closed;
+    std::thread _thread;
+public:
+    hashworker(std::function<void(const uint8_t*,size_t)> update)
+        : _update(update), _closed(false), _thread([this]() { run(); })
+    {
+    }
+    ~hashworker()
+    {
+        close();
+    }
+    void push(ByteVector_ptr chunk)
+    {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _cv.wait(lock, [this]() { return _queue.size()<MAXQUEUE; });
+        _queue.push_back(chunk);
+        _cv.notify_all();
+    }
+    // returns after all queued chunks have been hashed
+    void close()
+    {
+        {
+        std::unique_lock<std::mutex> lock(_mtx);
+        _closed= true;
+        _cv.notify_all();
+        }
+        if (_thread.joinable())
+            _thread.join();
+    }
+private:
+    void run()
+    {
+        while (true) {
+            ByteVector_ptr chunk;
+            {
+            std::unique_lock<std::mutex> lock(_mtx);
+            _cv.wait(lock, [this]() { return _closed || !_queue.empty(); });
+            if (_queue.empty())
+                return;
+            chunk= _queue.front();
+            _queue.pop_front();
+            _cv.notify_all();
+            }
+            _update(chunk->data(), chunk->size());
+        }
+    }
+};
+
+// calculates sha256 and xxh3 of a stream while it is being copied.
+// each digest runs on its own thread, so hashing overlaps with the disk i/o.
+class filehasher {
+    EVP_MD_CTX *_sha;
+    XXH3_state_t *_xxh;
+    uint64_t _size;
+    // set by the workers, only read after they are closed
+    bool _shafailed;
+    bool _xxhfailed;
+    hashworker _shaworker;
+    hashworker _xxhworker;
+public:
+    filehasher()
+        : _sha(EVP_MD_CTX_new()), _xxh(XXH3_createState()), _size(0),
+          _shafailed(false), _xxhfailed(false),
+          _shaworker([this](const uint8_t*p, size_t n) { if (EVP_DigestUpdate(_sha, p, n)!=1) _shafailed= true; }),
+          _xxhworker([this](const uint8_t*p, size_t n) { if (XXH3_64bits_update(_xxh, p, n)!=XXH_OK) _xxhfailed= true; })
+    {
+        if (!_sha || !_xxh || EVP_DigestInit_ex(_sha, EVP_sha256(), nullptr)!=1 || XXH3_64bits_reset(_xxh)!=XXH_OK) {
+            EVP_MD_CTX_free(_sha);
+            XXH3_freeState(_xxh);
+            throw "hash init failed";
+        }
+    }
+    ~filehasher()
+    {
+        _shaworker.close();
+        _xxhworker.close();
+        EVP_MD_CTX_free(_sha);
+        XXH3_freeState(_xxh);
+    }
+    void add(ByteVector_ptr chunk)
+    {
+        _size += chunk->size();
+        _shaworker.push(chunk);
+        _xxhworker.push(chunk);
+    }
+    // returns: "<sha256> <xxh3> <size>"
+    std::string finish()
+    {
+        _shaworker.close();
+        _xxhworker.close();
+
+        uint8_t md[EVP_MAX_MD_SIZE];
+        unsigned mdlen= 0;
+        if (_shafailed || EVP_DigestFinal_ex(_sha, md, &mdlen)!=1)
+            throw "sha256 failed";
+        if (_xxhfailed)
+            throw "xxh3 failed";
+
+        std::string result;
+        for (unsigned i=0 ; i<mdlen ; i++)
+            result += stringformat("%02x", md[i]);
+        result += stringformat(" %016llx %llu", (unsigned long long)XXH3_64bits_digest(_xxh), (unsigned long long)_size);
+        return result;
+    }
+};
+#endif
+
 // /Users/itsme/gitprj/repos/ntfsprogs-2.0.0/include/ntfs/layout.h
 class ntfsdisk;
 typedef std::shared_ptr<ntfsdisk> ntfsdisk_ptr;
@@ -73,8 +200,11 @@ public:
             std::string _name;
             std::string _filename;
             bool _islongfilename;
-            std::map<uint64_t,uint64_t> _lcnmap;
+            // lcn/length pairs, in vcn order
+            typedef std::vector<std::pair<uint64_t,uint64_t> > runlist_t;
+            runlist_t _runs;
         public:
+            enum { SPARSE_LCN= ~uint64_t(0) };
             enum {
                     AT_UNUSED			= 0,
                     AT_STANDARD_INFORMATION	= 0x10,
@@ -173,21 +303,30 @@ public:
                             break;
                         uint8_t ofssize= hdr>>4;
                         uint8_t lensize= hdr&15;
+                        if (lensize==0 || lensize>8 || ofssize>8 || p+lensize+ofssize>pend)
+                            throw "invalid runlist";
 
                         uint64_t len=0;
                         for (int i=0 ; i<lensize ; i++) {
-                            len|=(*p++)<<(8*i);
+                            len|=uint64_t(*p++)<<(8*i);
                         }
-                        uint64_t ofs=0;
+                        // the lcn delta is signed, relative to the previous run's lcn.
+                        // a run without lcn is sparse.
+                        int64_t delta=0;
                         for (int i=0 ; i<ofssize ; i++) {
-                            ofs|=(*p++)<<(8*i);
+                            delta|=uint64_t(*p++)<<(8*i);
                         }
+                        if (ofssize && ofssize<8 && (p[-1]&0x80))
+                            delta|= ~uint64_t(0)<<(8*ofssize);
 
-                        lcn += ofs;
+                        if (ofssize) {
+                            lcn += delta;
+                            _runs.push_back(std::make_pair(lcn, len));
+                        }
+                        else {
+                            _runs.push_back(std::make_pair(uint64_t(SPARSE_LCN), len));
+                        }
                         //printf("lcn: %llx, l=%x\n", lcn, len);
-
-                        _lcnmap[lcn]= len;
-                        lcn += len;
                     }
                     _data.resize(0);
                 }
@@ -199,21 +338,68 @@ public:
                     //printf("fn[%d]: %s\n", _islongfilename, _filename.c_str());
                 }
             }
-            void copyto(ReadWriter_ptr rw)
+            // copies the data in chunks, each chunk is also passed to onchunk
+            void copyto(ReadWriter_ptr rw, std::function<void(ByteVector_ptr)> onchunk= nullptr)
             {
                 uint64_t total= 0;
                 if (_nonresident) {
-                    std::for_each(_lcnmap.begin(), _lcnmap.end(), [this,rw,&total](const std::map<uint64_t,uint64_t>::value_type& kv) { 
-                            _disk->rd()->setpos(kv.first*_disk->clustersize());
-                            _disk->rd()->copyto(rw, std::min(_diskdatasize-total, kv.second*_disk->clustersize()));
+                    std::for_each(_runs.begin(), _runs.end(), [this,rw,onchunk,&total](const runlist_t::value_type& kv) { 
+                            if (kv.first!=SPARSE_LCN)
+                                _disk->rd()->setpos(kv.first*_disk->clustersize());
+                            uint64_t want= std::min(_diskdatasize-total, kv.second*_disk->clustersize());
+                            while (want) {
+                                auto chunk= std::make_shared<ByteVector>(std::min(want, uint64_t(0x100000)));
+                                size_t n= chunk->size();
+                                if (kv.first!=SPARSE_LCN)
+                                    n= _disk->rd()->read(chunk->data(), chunk->size());
+                                if (n==0)
+                                    throw "read error";
+                                chunk->resize(n);
+                                rw->write(chunk->data(), n);
+                                if (onchunk)
+                                    onchunk(chunk);
+                                want -= n;
+                                total += n;
+                            }
                     });
                 }
+                else if (!_data.empty()) {
+                    auto chunk= std::make_shared<ByteVector>(_data);
+                    rw->write(chunk->data(), chunk->size());
+                    if (onchunk)
+                        onchunk(chunk);
+                }
+            }
+            uint64_t datasize() const { return _nonresident ? _diskdatasize : 0; }
+            // read the entire nonresident contents into p, which must hold datasize() bytes.
+            // throws when the data can't be read completely.
+            void readdata(uint8_t *p, uint64_t size)
+            {
+                if (!_nonresident || size!=_diskdatasize)
+                    throw "datasize mismatch";
+                if (_lowvcn!=0)
+                    throw "runlist continues in other mft record";
+                uint64_t total= 0;
+                std::for_each(_runs.begin(), _runs.end(), [this,p,size,&total](const runlist_t::value_type& kv) { 
+                        uint64_t n= std::min(size-total, kv.second*_disk->clustersize());
+                        if (n==0)
+                            return;
+                        if (kv.first==SPARSE_LCN)
+                            throw "sparse run";
+                        _disk->rd()->setpos(kv.first*_disk->clustersize());
+                        if (_disk->rd()->read(p+total, n)!=n)
+                            throw "short read";
+                        total += n;
+                });
+                if (total<size)
+                    throw "runlist shorter than datasize";
             }
             uint64_t firstcluster()
             {
-                if (_lcnmap.empty())
+                auto i= std::find_if(_runs.begin(), _runs.end(), [](const runlist_t::value_type& kv) { return kv.first!=SPARSE_LCN; });
+                if (i==_runs.end())
                     return 0;
-                return _lcnmap.begin()->first;
+                return i->first;
             }
 
             void dump()
@@ -224,7 +410,12 @@ public:
                             _lowvcn, _highvcn, _diskallocsize, _diskdatasize, _diskinitsize, _vcnmapoffset);
 
                     printf("lcnmap: ");
-                    std::for_each(_lcnmap.begin(), _lcnmap.end(), [](const std::map<uint64_t,uint64_t>::value_type& kv) { printf(" %llx..%llx", kv.first, kv.first+kv.second-1); });
+                    std::for_each(_runs.begin(), _runs.end(), [](const runlist_t::value_type& kv) {
+                            if (kv.first==SPARSE_LCN)
+                                printf(" sparse:%llx", kv.second);
+                            else
+                                printf(" %llx..%llx", kv.first, kv.first+kv.second-1);
+                    });
                     printf("\n");
                 }
                 else {
@@ -308,13 +499,27 @@ public:
             printf("%llx : LSN:%llx, bytes:%08x/%08x, base=%llx\n", _ofs, _lsn, _bytesused, _bytesalloced, _basemftrecord);
             std::for_each(_attrs.begin(), _attrs.end(), [](ntfsattr_ptr p) { p->dump(); });
         }
-        void save(const std::string& savename)
+        void save(const std::string& savename, std::function<void(ByteVector_ptr)> onchunk= nullptr)
         {
             ReadWriter_ptr fsave(new FileReader(savename, FileReader::createnew));
 
             ntfsattr_ptr dattr= find_attr_for_type(ntfsattr::AT_DATA);  // AT_VOLUME_INFORMATION ??
             if (dattr)
-                dattr->copyto(fsave);
+                dattr->copyto(fsave, onchunk);
+        }
+        uint64_t datasize()
+        {
+            ntfsattr_ptr dattr= find_attr_for_type(ntfsattr::AT_DATA);
+            if (!dattr)
+                throw "no data attribute";
+            return dattr->datasize();
+        }
+        void readdata(uint8_t *p, uint64_t size)
+        {
+            ntfsattr_ptr dattr= find_attr_for_type(ntfsattr::AT_DATA);
+            if (!dattr)
+                throw "no data attribute";
+            dattr->readdata(p, size);
         }
         uint64_t firstcluster()
         {
@@ -374,9 +579,11 @@ class ntfsboot {
     uint64_t _ofs;
 
     uint32_t _clustersize;
+    uint32_t _sectorsize;
     uint64_t _nsectors;
     uint64_t _mftlcn;
     uint64_t _mirrmftlcn;
+    uint32_t _mftrecordsize;
     public:
         ntfsboot(ReadWriter_ptr r, uint64_t ofs)
             : _r(r), _ofs(ofs)
@@ -394,6 +601,7 @@ class ntfsboot {
         uint16_t bytespersector= _r->read16le();
         uint8_t sectorspercluster= _r->read8();
 
+        _sectorsize= bytespersector;
         _clustersize= bytespersector*sectorspercluster;
 
         _r->setpos(_ofs+0x28);
@@ -401,29 +609,113 @@ class ntfsboot {
         _mftlcn= _r->read64le();
         _mirrmftlcn= _r->read64le();
 
+        // positive: clusters per record, negative: log2 of the bytesize
+        int8_t clusterspermftrecord= _r->read8();
+        if (clusterspermftrecord<0)
+            _mftrecordsize= 1<<(-clusterspermftrecord);
+        else
+            _mftrecordsize= clusterspermftrecord*_clustersize;
+
         return true;
     }
     uint32_t clustersize() const { return _clustersize; };
     uint64_t nsectors() const { return _nsectors; };
+    uint64_t nclusters() const { return _clustersize ? _nsectors*_sectorsize/_clustersize : 0; };
     uint64_t mftclus() const { return _mftlcn; };
     uint64_t mirclus() const { return _mirrmftlcn; };
+    uint32_t mftrecordsize() const { return _mftrecordsize; };
+};
+
+// the $Bitmap contents: one bit per cluster, set when the cluster is in use.
+// cluster numbers are relative to the volume start, which is where the bootsector is.
+class ntfsbitmap {
+    uint64_t _volstart;
+    uint32_t _clustersize;
+    std::vector<uint64_t> _bits;
+    uint64_t _nclusters;
+public:
+    // nclusters is the volume size from the bootsector, $Bitmap is padded to a multiple of 8 bytes.
+    ntfsbitmap(ntfsdisk::ntfsfile& nf, uint64_t volstart, uint32_t clustersize, uint64_t nclusters)
+        : _volstart(volstart), _clustersize(clustersize)
+    {
+        uint64_t size= nf.datasize();
+        if (size > (((nclusters+7)/8+7)&~uint64_t(7)))
+            throw "$Bitmap larger than volume";
+        _bits.resize((size+7)/8);
+        _nclusters= std::min(nclusters, size*8);
+
+        // read directly into the word vector, then fix the byte order in place
+        nf.readdata((uint8_t*)_bits.data(), size);
+        for (auto& w : _bits) {
+            const uint8_t *b= (const uint8_t*)&w;
+            uint64_t v= 0;
+            for (int i=0 ; i<8 ; i++)
+                v |= uint64_t(b[i])<<(8*i);
+            w= v;
+        }
+    }
+    uint64_t volstart() const { return _volstart; }
+    uint32_t clustersize() const { return _clustersize; }
+    uint64_t nclusters() const { return _nclusters; }
+    bool isallocated(uint64_t lcn) const
+    {
+        return (_bits[lcn/64]>>(lcn%64))&1;
+    }
+    // returns the first cluster after lcn with a different allocation state,
+    // skipping whole words at a time.
+    uint64_t runend(uint64_t lcn) const
+    {
+        uint64_t invert= isallocated(lcn) ? ~uint64_t(0) : 0;
+        uint64_t w= lcn/64;
+        uint64_t x= (_bits[w]^invert) & (~uint64_t(0)<<(lcn%64));
+        while (x==0) {
+            if (++w==_bits.size())
+                return _nclusters;
+            x= _bits[w]^invert;
+        }
+        return std::min(w*64+std::countr_zero(x), _nclusters);
+    }
+    // returns the first offset at or after ofs which is in a wanted cluster.
+    // offsets outside the volume are always wanted.
+    uint64_t nextofs(uint64_t ofs, bool wantallocated) const
+    {
+        if (ofs<_volstart)
+            return ofs;
+        uint64_t lcn= (ofs-_volstart)/_clustersize;
+        if (lcn>=_nclusters || isallocated(lcn)==wantallocated)
+            return ofs;
+        return _volstart+runend(lcn)*_clustersize;
+    }
 };
+typedef std::shared_ptr<ntfsbitmap> ntfsbitmap_ptr;
 
 void usage()
 {
     fprintf(stderr, "Usage: ntfsrd [options] {dev|image} [extract list]\n");
     fprintf(stderr, "  -v     verbose\n");
     fprintf(stderr, "  -d SAVEDIR     specify where to save extracted files\n");
+#ifdef WITH_OPENSSL
+    fprintf(stderr, "  -H MANIFEST    write sha256, xxh3 and size of extracted files to MANIFEST\n");
+    fprintf(stderr, "                 files are then saved as SAVEDIR/<mft record offset>_<name>\n");
+#endif
     fprintf(stderr, "  -o DISKSTART\n");
     fprintf(stderr, "  -l DISKSIZE\n");
     fprintf(stderr, "  -c CLUSSIZE    specify clustersize\n");
     fprintf(stderr, "  -f OFFSET      where to start searching\n");
     fprintf(stderr, "  -m OFFSET      specify mft offset\n");
     fprintf(stderr, "  -b OFFSET      specify boot offset\n");
+    fprintf(stderr, "  -u     only scan clusters marked free in $Bitmap\n");
+    fprintf(stderr, "  -a     only scan clusters marked allocated in $Bitmap\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "the CLUSSIZE and DISKSTART are needed when you want to copy files\n");
     fprintf(stderr, "they can either be obtained from the bootsector, or manually specified\n");
     fprintf(stderr, "specifying DISKSIZE allows ntfsrd to look at the 2nd copy of the bootsector\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "with -u or -a, $Bitmap is loaded from the first bootsector found, and the scan\n");
+    fprintf(stderr, "is restricted within that volume from then on. specify the boot offset to load\n");
+    fprintf(stderr, "$Bitmap before scanning.\n");
+    fprintf(stderr, "note that -u skips the live $MFT, $MFTMirr and bootsector clusters, so deleted\n");
+    fprintf(stderr, "records in the live $MFT are not found, and no diskstart can be inferred.\n");
 }
 template<typename V, typename P>
 bool all(const typename V::value_type& x, V v, P pred)
@@ -443,8 +735,10 @@ bool any(const typename V::value_type& x, V v, P pred)
 int main(int argc,char**argv)
 {
     bool verbose= false;
+    enum { SCAN_ALL, SCAN_FREE, SCAN_ALLOCATED } scanmode= SCAN_ALL;
     std::string devname;
     std::string savedir;
+    std::string manifestname;
     uint64_t diskstart=0;    bool diskstartspecified = false;
     uint64_t disksize=0;
     uint64_t fileentofs= 0;  bool filentspecified = false;
@@ -462,12 +756,21 @@ int main(int argc,char**argv)
         {
             case 'v': verbose=true; break;
             case 'd': savedir = getstrarg(argv, i, argc); break;
+#ifdef WITH_OPENSSL
+            case 'H': manifestname = getstrarg(argv, i, argc); break;
+#endif
             case 'o': diskstart = getintarg(argv, i, argc); break;
             case 'l': disksize = getintarg(argv, i, argc); break;
             case 'c': clustersize = getintarg(argv, i, argc); break;
             case 'f': fileentofs = getintarg(argv, i, argc); filentspecified = true; break;
             case 'm': mtfent_offset = getintarg(argv, i, argc); break;
             case 'b': bootofs.push_back( getintarg(argv, i, argc) ); break;
+            case 'u':
+            case 'a':
+                      if (scanmode!=SCAN_ALL)
+                          fprintf(stderr, "WARNING: both -u and -a specified, using %s\n", argv[i]);
+                      scanmode= argv[i][1]=='u' ? SCAN_FREE : SCAN_ALLOCATED;
+                      break;
             default:
                       usage();
                       return 1;
@@ -499,6 +802,14 @@ int main(int argc,char**argv)
         printf("restricted to %08llx - %08llx\n", diskstart, disksize);
     }
 
+    std::shared_ptr<FILE> manifest;
+    if (!manifestname.empty()) {
+        FILE *fh= fopen(manifestname.c_str(), "w");
+        if (fh==NULL)
+            throw "could not create manifest";
+        manifest.reset(fh, fclose);
+    }
+
     ntfsdisk_ptr disk(new ntfsdisk(f));
     if (clustersize) 
         disk->setclustersize(clustersize);
@@ -524,8 +835,45 @@ int main(int argc,char**argv)
  
     if (mtfent_offset)
         mftentofs.push_back(mtfent_offset);
+    // $Bitmap is mft record #6 of the volume starting at the bootsector,
+    // its cluster numbers are relative to that bootsector.
+    ntfsbitmap_ptr bitmap;
+    auto loadbitmap= [&bitmap, f](uint64_t volstart) {
+        try {
+        ntfsboot boot(f, volstart);
+        if (boot.clustersize()==0 || boot.mftrecordsize()==0)
+            throw "invalid bootsector";
+        ntfsdisk_ptr vol(new ntfsdisk(ReadWriter_ptr(new OffsetReader(f, volstart, f->size()-volstart))));
+        vol->setclustersize(boot.clustersize());
+        ntfsdisk::ntfsfile nf(vol, boot.mftclus()*boot.clustersize()+6*boot.mftrecordsize());
+        if (nf.filename()!="$Bitmap")
+            throw "$Bitmap not found at mft record #6";
+        bitmap.reset(new ntfsbitmap(nf, volstart, boot.clustersize(), boot.nclusters()));
+        printf("$Bitmap: 0x%llx clusters, volume at 0x%llx\n", bitmap->nclusters(), volstart);
+        }
+        catch(const std::exception& e) {
+            printf("ERR loading $Bitmap for volume at %08llx: %s\n", volstart, e.what());
+        }
+        catch(const char*msg) {
+            printf("ERR loading $Bitmap for volume at %08llx: %s\n", volstart, msg);
+        }
+    };
+    // returns the first offset at or after ofs which is not excluded by the bitmap
+    auto nextofs= [&bitmap, scanmode](uint64_t ofs) {
+        if (!bitmap || scanmode==SCAN_ALL)
+            return ofs;
+        return bitmap->nextofs(ofs, scanmode==SCAN_ALLOCATED);
+    };
+
+    if (scanmode!=SCAN_ALL && !bootofs.empty()) {
+        loadbitmap(bootofs.front());
+        if (bitmap)
+            disk->setclustersize(bitmap->clustersize());
+    }
+
     HiresTimer t;
-    for (uint64_t ofs= fileentofs ; ofs < (filentspecified ? (fileentofs+0x200) : f->size()) ; ofs+=0x200)
+    uint64_t lastreport= fileentofs;
+    for (uint64_t ofs= nextofs(fileentofs) ; ofs < (filentspecified ? (fileentofs+0x200) : f->size()) ; ofs= nextofs(ofs+0x200))
     {
         f->setpos(ofs);
         try {
@@ -536,8 +884,21 @@ int main(int argc,char**argv)
             if (verbose)
                 nf.dump();
             if (!files.empty() && files.end()!=files.find(nf.filename())) {
-                if (disk->clustersize())
+                if (disk->clustersize()) {
+#ifdef WITH_OPENSSL
+                    if (manifest) {
+                        // several records can have the same name, prefix the record offset
+                        // so each manifest line refers to its own file.
+                        std::string savename= savedir + stringformat("%llx_", ofs) + nf.filename();
+                        filehasher hash;
+                        nf.save(savename, [&hash](ByteVector_ptr chunk) { hash.add(chunk); });
+                        fprintf(manifest.get(), "%s %s\n", hash.finish().c_str(), savename.c_str());
+                        fflush(manifest.get());
+                    }
+                    else
+#endif
                     nf.save(savedir + nf.filename());
+                }
                 else {
                     printf("can't save files when clustersize is unknown\n");
                     return 1;
@@ -560,6 +921,9 @@ int main(int argc,char**argv)
             setmirclus(boot.mirclus());
             setdsksize(boot.nsectors());
             bootofs.push_back(ofs);
+
+            if (scanmode!=SCAN_ALL && !bitmap)
+                loadbitmap(ofs);
         }
         }
         catch(const std::exception& e) {
@@ -571,8 +935,9 @@ int main(int argc,char**argv)
         catch(...) {
             printf("ERR reading %08llx\n", ofs);
         }
-        if ((ofs&0xFFFFFFF)==0) {
-            fprintf(stderr, "%12llx  %9.0f bytes/sec      \r", ofs, double(1000000.0*0x10000000)/t.lap());
+        if ((ofs>>28)!=(lastreport>>28)) {
+            fprintf(stderr, "%12llx  %9.0f bytes/sec      \r", ofs, double(1000000.0*(ofs-lastreport))/t.lap());
+            lastreport= ofs;
         }
     }
     printf("FOUND: mft=0x%llx, mir=0x%llx dsk=0x%llx  clus=0x%x\n", mftclus, mirclus, dsksize, disk->clustersize());